@@ -0,0 +1,447 @@
+/* File Synopsis:
+ * This file contains functions that check whether the brackets (), [] and {} in a string, stream or file are
+ * balanced. The input is read once from start to end, a chunk at a time, with a stack of the opening
+ * brackets that have not been closed yet, so apart from that stack memory use does not depend on the input
+ * size. Most text has long stretches with no brackets at all, so the scan looks at eight bytes at a time and
+ * skips any group of eight that has no bracket in it. When the brackets are not balanced, the byte offset of
+ * the first problem is reported.
+ *
+ * The checkBracketsInFileParallel function splits a file into one range per thread. Each range is checked on
+ * its own, keeping only the closing brackets it could not match and the opening brackets it left open, and
+ * those summaries are then combined in order to get the same answer as checking the whole file at once.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "parallel.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const int kChunkBytes = 1 << 20;//number of bytes read from the input at a time
+
+/* Struct Synopsis:
+ * A BracketResult is the outcome of a bracket check. When the brackets are not balanced, errorOffset is the
+ * byte offset of the first closing bracket that does not match, or, if every closing bracket matched, of
+ * the first opening bracket that was never closed. When the brackets are balanced, errorOffset is -1.
+ */
+struct BracketResult {
+    bool balanced;
+    long long errorOffset;
+};
+
+/* Struct Synopsis:
+ * A Bracket is one bracket character together with its byte offset in the input.
+ */
+struct Bracket {
+    char ch;
+    long long offset;
+};
+
+/* Struct Synopsis:
+ * A BracketSummary holds what scanning part of the input found out. open is the stack of opening brackets
+ * that are still waiting to be closed. unmatchedClose lists, in order, the closing brackets that came when
+ * open was empty; they can only be matched by opening brackets from earlier in the input. mismatchOffset is
+ * the offset of a closing bracket that did not match the opening bracket on top of open, or -1 if there has
+ * not been one. Scanning stops at a mismatch because nothing earlier in the input can fix it.
+ */
+struct BracketSummary {
+    vector<Bracket> open;
+    vector<Bracket> unmatchedClose;
+    long long mismatchOffset = -1;
+};
+
+/* Function Synopsis:
+ * Returns the opening bracket that goes with the given closing bracket.
+ */
+char openerFor(char closer){
+    if(closer == ')'){
+        return '(';
+    }
+    return closer - 2;//'[' and '{' are two characters before ']' and '}'
+}
+
+/* Function Synopsis:
+ * Returns true if any of the eight bytes packed into word is a bracket. The test runs on all eight bytes at
+ * once: ( and ) only differ in their lowest bit, and [ and { as well as ] and } only differ in the bit
+ * worth 0x20, so setting that bit in every byte leaves three byte values to look for. A byte equals a value
+ * when the byte XOR the value is zero, and the expression (x - 0x01...) & ~x & 0x80... has a high bit set
+ * exactly when some byte of x is zero.
+ */
+bool containsBracket(uint64_t word){
+    const uint64_t kOnes = 0x0101010101010101ULL;
+    const uint64_t kHighBits = 0x8080808080808080ULL;
+    auto hasZeroByte = [&](uint64_t x){
+        return ((x - kOnes) & ~x & kHighBits) != 0;
+    };
+
+    uint64_t parens = (word | kOnes) ^ (kOnes * ')');
+    uint64_t openers = (word | (kOnes * 0x20)) ^ (kOnes * '{');
+    uint64_t closers = (word | (kOnes * 0x20)) ^ (kOnes * '}');
+    return hasZeroByte(parens) || hasZeroByte(openers) || hasZeroByte(closers);
+}
+
+/* Function Synopsis:
+ * This function scans size bytes starting at data, where data[0] is at byte offset startOffset in the whole
+ * input, and adds what it finds to summary. The summary is passed by reference so that one summary can be
+ * carried across the chunks of a longer input. The bytes are checked eight at a time with containsBracket,
+ * and only groups of eight that contain a bracket are looked at one byte at a time.
+ */
+void scanBrackets(const char* data, size_t size, long long startOffset, BracketSummary& summary){
+    if(summary.mismatchOffset >= 0){
+        return;
+    }
+    for(size_t i = 0; i < size; i += 8){
+        size_t end = min(size, i + 8);
+        if(end - i == 8){
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            if(!containsBracket(word)){
+                continue;
+            }
+        }
+
+        for(size_t j = i; j < end; j++){
+            char ch = data[j];
+            if(ch == '(' || ch == '[' || ch == '{'){
+                summary.open.push_back({ch, startOffset + (long long)j});
+            }
+            else if(ch == ')' || ch == ']' || ch == '}'){
+                if(summary.open.empty()){
+                    summary.unmatchedClose.push_back({ch, startOffset + (long long)j});
+                }
+                else if(summary.open.back().ch == openerFor(ch)){
+                    summary.open.pop_back();
+                }
+                else{
+                    summary.mismatchOffset = startOffset + (long long)j;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+/* Function Synopsis:
+ * This function combines the summaries of consecutive parts of an input, in order, into the result for the
+ * whole input. The opening brackets left open by earlier parts are kept on a stack, and each part's
+ * unmatched closing brackets are matched against that stack before its own mismatch and open brackets are
+ * considered, which is the same order a single scan of the whole input would see them in.
+ */
+BracketResult combineSummaries(const vector<BracketSummary>& summaries){
+    vector<Bracket> open;
+    for(const BracketSummary& summary : summaries){
+        for(const Bracket& closer : summary.unmatchedClose){
+            if(open.empty() || open.back().ch != openerFor(closer.ch)){
+                return {false, closer.offset};
+            }
+            open.pop_back();
+        }
+        if(summary.mismatchOffset >= 0){
+            return {false, summary.mismatchOffset};
+        }
+        open.insert(open.end(), summary.open.begin(), summary.open.end());
+    }
+
+    if(!open.empty()){
+        return {false, open[0].offset};
+    }
+    return {true, -1};
+}
+
+/* Function Synopsis:
+ * This function checks the brackets in everything that can be read from in, reading kChunkBytes bytes at a
+ * time. It stops reading as soon as a closing bracket is found that cannot be matched.
+ */
+BracketResult checkBrackets(istream& in){
+    vector<char> buffer(kChunkBytes);
+    BracketSummary summary;
+    long long offset = 0;
+
+    while(in){
+        in.read(buffer.data(), buffer.size());
+        size_t count = in.gcount();
+        scanBrackets(buffer.data(), count, offset, summary);
+        offset += count;
+        if(!summary.unmatchedClose.empty() || summary.mismatchOffset >= 0){
+            break;
+        }
+    }
+    return combineSummaries({summary});
+}
+
+/* Function Synopsis:
+ * This function returns true if the brackets in str are balanced.
+ */
+bool isBalanced(string str){
+    istringstream in(str);
+    return checkBrackets(in).balanced;
+}
+
+/* Function Synopsis:
+ * This function checks the brackets in the named file. An error is reported if the file cannot be opened.
+ */
+BracketResult checkBracketsInFile(string filename){
+    ifstream in(filename, ios::binary);
+    if(!in){
+        error("checkBracketsInFile: cannot open " + filename);
+    }
+    return checkBrackets(in);
+}
+
+/* Function Synopsis:
+ * This function gives the same result as checkBracketsInFile using numThreads threads. The file is split into
+ * numThreads ranges of about the same size, and each thread opens the file on its own and scans its range a
+ * chunk at a time into a BracketSummary. The summaries are then combined in file order. An error is reported
+ * if the file cannot be opened or numThreads is less than 1.
+ */
+BracketResult checkBracketsInFileParallel(string filename, int numThreads){
+    if(numThreads < 1){
+        error("checkBracketsInFileParallel: numThreads must be at least 1");
+    }
+    ifstream file(filename, ios::binary | ios::ate);
+    if(!file){
+        error("checkBracketsInFileParallel: cannot open " + filename);
+    }
+    long long fileSize = file.tellg();
+    long long rangeSize = (fileSize + numThreads - 1) / numThreads;
+
+    vector<BracketSummary> summaries(numThreads);
+    vector<char> readFailed(numThreads, false);//not vector<bool>, whose elements share bytes between threads
+    runInParallel(numThreads, [&](int t){
+        long long start = min(fileSize, t * rangeSize);
+        long long end = min(fileSize, start + rangeSize);
+        ifstream in(filename, ios::binary);
+        in.seekg(start);
+        vector<char> buffer(min<long long>(kChunkBytes, max(1LL, end - start)));
+
+        for(long long offset = start; offset < end && summaries[t].mismatchOffset < 0; ){
+            long long count = min<long long>(buffer.size(), end - offset);
+            if(!in.read(buffer.data(), count)){
+                readFailed[t] = true;
+                return;
+            }
+            scanBrackets(buffer.data(), count, offset, summaries[t]);
+            offset += count;
+        }
+    });
+
+    for(char failed : readFailed){
+        if(failed){
+            error("checkBracketsInFileParallel: cannot read " + filename);
+        }
+    }
+    return combineSummaries(summaries);
+}
+
+
+/* * * * * * Test Code Below This Point * * * * * */
+
+/*
+ * These utility functions are the classic recursive check: keep only the brackets, then repeatedly remove
+ * an adjacent matching pair such as "()" until nothing is left. Each removal copies the string, so it takes
+ * O(N^2) time. They are used to check isBalanced against.
+ */
+string operatorsFrom(string str){
+    if(str.empty()){
+        return "";
+    }
+    string rest = operatorsFrom(str.substr(1));
+    return (string("()[]{}").find(str[0]) != string::npos) ? str[0] + rest : rest;
+}
+
+bool operatorsAreMatched(string ops){
+    if(ops.empty()){
+        return true;
+    }
+    for(string pair : {"()", "[]", "{}"}){
+        size_t index = ops.find(pair);
+        if(index != string::npos){
+            return operatorsAreMatched(ops.erase(index, 2));
+        }
+    }
+    return false;
+}
+
+/*
+ * This utility function returns a string of the given length made of random letters, spaces and brackets,
+ * where about one character in bracketEvery is a bracket.
+ */
+string randomBracketText(int length, int bracketEvery){
+    const string kBrackets = "()[]{}";
+    string text;
+    for(int i = 0; i < length; i++){
+        if(randomInteger(1, bracketEvery) == 1){
+            text += kBrackets[randomInteger(0, 5)];
+        }
+        else{
+            text += (char)randomInteger('a', 'z');
+        }
+    }
+    return text;
+}
+
+/*
+ * This utility function returns a string of the given length where the brackets are balanced, made by
+ * nesting and chaining random pairs with plain text between them.
+ */
+string randomBalancedText(int length){
+    const string kOpeners = "([{";
+    const string kClosers = ")]}";
+    string text;
+    string waiting;//closing brackets still owed, innermost last
+    while((int)(text.size() + waiting.size()) < length){
+        int choice = randomInteger(0, 9);
+        if(choice < 2){
+            int kind = randomInteger(0, 2);
+            text += kOpeners[kind];
+            waiting += kClosers[kind];
+        }
+        else if(choice < 4 && !waiting.empty()){
+            text += waiting.back();
+            waiting.pop_back();
+        }
+        else{
+            text += "lorem ipsum ";
+        }
+    }
+    text.append(waiting.rbegin(), waiting.rend());
+    return text;
+}
+
+/*
+ * This utility function checks str with checkBrackets.
+ */
+BracketResult checkString(string str){
+    istringstream in(str);
+    return checkBrackets(in);
+}
+
+/*
+ * This utility function writes str to the named file.
+ */
+void writeFile(string filename, string str){
+    ofstream out(filename, ios::binary);
+    out << str;
+}
+
+STUDENT_TEST("isBalanced simple input"){
+    EXPECT(isBalanced(""));
+    EXPECT(isBalanced("no brackets at all"));
+    EXPECT(isBalanced("int main() { int x = 2 * (vec[3] + 4); }"));
+    EXPECT(isBalanced("{[()()]([])}"));
+    EXPECT(!isBalanced("("));
+    EXPECT(!isBalanced(")("));
+    EXPECT(!isBalanced("([)]"));
+    EXPECT(!isBalanced("{[}"));
+}
+
+STUDENT_TEST("checkBrackets reports the offset of the first problem"){
+    BracketResult result = checkString("if (x[0] == y) { return;");
+    EXPECT(!result.balanced);
+    EXPECT_EQUAL(result.errorOffset, 15);//the { is never closed
+
+    result = checkString("f(a[1)] + b)");
+    EXPECT(!result.balanced);
+    EXPECT_EQUAL(result.errorOffset, 5);//the ) does not match the [
+
+    result = checkString("x) (y");
+    EXPECT(!result.balanced);
+    EXPECT_EQUAL(result.errorOffset, 1);//the ) has nothing to match
+
+    result = checkString("((a) (b");
+    EXPECT(!result.balanced);
+    EXPECT_EQUAL(result.errorOffset, 0);//the first unclosed opening bracket
+
+    result = checkString("([{}])");
+    EXPECT(result.balanced);
+    EXPECT_EQUAL(result.errorOffset, -1);
+}
+
+STUDENT_TEST("containsBracket finds a bracket in any of the eight bytes"){
+    const string kBrackets = "()[]{}";
+    for(int position = 0; position < 8; position++){
+        for(int c = 0; c < 256; c++){
+            string bytes = "abcdefgh";
+            bytes[position] = (char)c;
+            uint64_t word;
+            memcpy(&word, bytes.data(), 8);
+            EXPECT_EQUAL(containsBracket(word), kBrackets.find((char)c) != string::npos);
+        }
+    }
+}
+
+STUDENT_TEST("isBalanced matches the recursive check on random input"){
+    for(int trial = 0; trial < 200; trial++){
+        string text = (trial % 2 == 0) ? randomBracketText(randomInteger(0, 40), 2)
+                                        : randomBalancedText(randomInteger(0, 200));
+        EXPECT_EQUAL(isBalanced(text), operatorsAreMatched(operatorsFrom(text)));
+    }
+}
+
+STUDENT_TEST("checkBrackets works across chunk boundaries"){
+    EXPECT(checkString(randomBalancedText(3 * kChunkBytes + 12345)).balanced);
+
+    string text(3 * kChunkBytes, 'x');
+    text[10] = '(';
+    text[kChunkBytes - 1] = '[';//opened at the end of one chunk and closed at the start of the next
+    text[kChunkBytes] = ']';
+    text[2 * kChunkBytes + 7] = ')';
+    EXPECT(checkString(text).balanced);
+
+    text[3 * kChunkBytes - 1] = '}';
+    BracketResult result = checkString(text);
+    EXPECT(!result.balanced);
+    EXPECT_EQUAL(result.errorOffset, 3 * kChunkBytes - 1);
+}
+
+STUDENT_TEST("checkBracketsInFileParallel matches checkBracketsInFile"){
+    for(int trial = 0; trial < 50; trial++){
+        string text = (trial % 2 == 0) ? randomBracketText(randomInteger(0, 200), 4)
+                                        : randomBalancedText(randomInteger(0, 2000));
+        if(trial % 4 == 1 && !text.empty()){
+            text[randomInteger(0, text.size() - 1)] = ')';
+        }
+        writeFile("brackets_test.txt", text);
+
+        BracketResult expected = checkBracketsInFile("brackets_test.txt");
+        for(int numThreads = 1; numThreads <= 8; numThreads++){
+            BracketResult result = checkBracketsInFileParallel("brackets_test.txt", numThreads);
+            EXPECT_EQUAL(result.balanced, expected.balanced);
+            EXPECT_EQUAL(result.errorOffset, expected.errorOffset);
+        }
+    }
+    EXPECT_ERROR(checkBracketsInFileParallel("brackets_test.txt", 0));
+    remove("brackets_test.txt");
+    EXPECT_ERROR(checkBracketsInFile("brackets_test.txt"));
+}
+
+STUDENT_TEST("Time recursive check vs isBalanced"){//the recursive check should grow quadratically
+    for(int n = 1000; n <= 8000; n *= 2){
+        string text = randomBalancedText(n);
+        TIME_OPERATION(n, operatorsAreMatched(operatorsFrom(text)));
+        TIME_OPERATION(n, isBalanced(text));
+    }
+}
+
+STUDENT_TEST("Time checkBracketsInFile and checkBracketsInFileParallel in MB/second"){
+    string text = randomBalancedText(64 << 20);
+    writeFile("brackets_timing.txt", text);
+    double megabytes = text.size() / double(1 << 20);
+
+    auto start = chrono::steady_clock::now();
+    checkBracketsInFile("brackets_timing.txt");
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "sequential: " << (long long)(megabytes / elapsed.count()) << " MB/second" << endl;
+
+    for(int numThreads = 1; numThreads <= 8; numThreads *= 2){
+        start = chrono::steady_clock::now();
+        checkBracketsInFileParallel("brackets_timing.txt", numThreads);
+        elapsed = chrono::steady_clock::now() - start;
+        cout << numThreads << " thread(s): " << (long long)(megabytes / elapsed.count()) << " MB/second" << endl;
+    }
+    remove("brackets_timing.txt");
+}
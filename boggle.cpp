@@ -0,0 +1,561 @@
+/* File Synopsis:
+ * This file contains a Boggle solver that scores boards against a word list. The word list is first turned
+ * into a LexiconTrie, a prefix tree stored as one array of small fixed-size nodes, so that looking up the
+ * next letter of a path is a single array access and the whole structure can be saved to and loaded from a
+ * file in one read. Each board is then searched by recursive backtracking from every cell, using a bitmask
+ * to remember which cells the current path has used and stopping as soon as the path is not the prefix of
+ * any word. Many boards can be scored at once on several threads that share the same read-only trie.
+ *
+ * A word scores points if it has at least kMinWordLength letters, each letter comes from a cell adjacent
+ * (including diagonally) to the one before it, and no cell is used twice. Each word scores length - 3 points
+ * and only counts once per board, however many paths spell it.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "grid.h"
+#include "gridlocation.h"
+#include "lexicon.h"
+#include "parallel.h"
+#include "set.h"
+#include "vector.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const int kMinWordLength = 4;
+const int kMaxBoardCells = 64;//one bit per cell in the visited bitmask
+const uint32_t kWordFlag = 1u << 31;//set in TrieNode::letters when the path to the node spells a word
+const uint32_t kLetterBits = (1u << 26) - 1;
+const char kTrieFileMagic[4] = {'T', 'R', 'I', 'E'};
+
+/* Struct Synopsis:
+ * A TrieNode stores which letters can follow the prefix it stands for as a bitmask (bit 0 for 'a' up to
+ * bit 25 for 'z'), plus kWordFlag when the prefix is a word. The children of a node are stored next to each
+ * other in letter order starting at firstChild, so the child for a letter is found by counting the set
+ * letter bits below it.
+ */
+struct TrieNode {
+    uint32_t firstChild;
+    uint32_t letters;
+};
+
+/* Class Synopsis:
+ * LexiconTrie is a read-only prefix tree of lowercase words stored as a flat array of TrieNodes in
+ * breadth-first order, with the root at index 0. It can be built from a Lexicon or a Vector of words, or
+ * loaded from a file written by save.
+ */
+class LexiconTrie {
+public:
+    LexiconTrie(const Lexicon& lex);
+    LexiconTrie(Vector<string> words);
+
+    int size() const;
+    int childFor(int node, int letter) const;
+    bool hasChildren(int node) const;
+    bool isWord(int node) const;
+    bool contains(string word) const;
+
+    void save(string filename) const;
+    static LexiconTrie load(string filename);
+
+private:
+    vector<TrieNode> nodes;
+
+    LexiconTrie() = default;
+    void build(Vector<string>& words);
+};
+
+/* Function Synopsis:
+ * Builds the trie from every word in the Lexicon.
+ */
+LexiconTrie::LexiconTrie(const Lexicon& lex){
+    Vector<string> words;
+    for(string word : lex){
+        words.add(word);
+    }
+    build(words);
+}
+
+/* Function Synopsis:
+ * Builds the trie from the given words. Upper case letters are treated as lower case, and words containing
+ * anything other than letters are skipped.
+ */
+LexiconTrie::LexiconTrie(Vector<string> words){
+    build(words);
+}
+
+/* Function Synopsis:
+ * This helper fills in the node array. The words are sorted so that the words sharing any prefix form one
+ * consecutive range. Nodes are then created a level at a time using a queue of ranges: the node for a prefix
+ * of length depth covers the range of words starting with that prefix, and its children are the distinct
+ * letters at index depth within that range. All the children of a node are added to the array together,
+ * which keeps them next to each other.
+ */
+void LexiconTrie::build(Vector<string>& words){
+    Vector<string> cleaned;
+    for(string word : words){
+        bool valid = !word.empty();
+        for(char& ch : word){
+            ch = tolower((unsigned char)ch);
+            valid = valid && ch >= 'a' && ch <= 'z';
+        }
+        if(valid){
+            cleaned.add(word);
+        }
+    }
+    cleaned.sort();
+
+    struct Range {
+        int node;
+        int lo;//first word with this prefix
+        int hi;//one past the last word with this prefix
+        int depth;
+    };
+    vector<Range> queue = {{0, 0, cleaned.size(), 0}};
+    nodes.assign(1, {0, 0});
+
+    for(size_t next = 0; next < queue.size(); next++){
+        Range range = queue[next];
+        int lo = range.lo;
+        while(lo < range.hi && (int)cleaned[lo].size() == range.depth){//sorted order puts the prefix and its copies first
+            nodes[range.node].letters |= kWordFlag;
+            lo++;
+        }
+
+        nodes[range.node].firstChild = nodes.size();
+        while(lo < range.hi){
+            char letter = cleaned[lo][range.depth];
+            int hi = lo;
+            while(hi < range.hi && cleaned[hi][range.depth] == letter){
+                hi++;
+            }
+            nodes[range.node].letters |= 1u << (letter - 'a');
+            queue.push_back({(int)nodes.size(), lo, hi, range.depth + 1});
+            nodes.push_back({0, 0});
+            lo = hi;
+        }
+    }
+}
+
+/* Function Synopsis:
+ * Returns the number of nodes in the trie.
+ */
+int LexiconTrie::size() const{
+    return nodes.size();
+}
+
+/* Function Synopsis:
+ * Returns the index of the child of node reached by the given letter (0 for 'a' up to 25 for 'z'), or -1
+ * if no word continues that way.
+ */
+int LexiconTrie::childFor(int node, int letter) const{
+    uint32_t letters = nodes[node].letters;
+    uint32_t bit = 1u << letter;
+    if((letters & bit) == 0){
+        return -1;
+    }
+    return nodes[node].firstChild + bitset<32>(letters & (bit - 1)).count();
+}
+
+/* Function Synopsis:
+ * Returns true if some word is longer than the prefix that node stands for.
+ */
+bool LexiconTrie::hasChildren(int node) const{
+    return (nodes[node].letters & kLetterBits) != 0;
+}
+
+/* Function Synopsis:
+ * Returns true if the prefix that node stands for is a word.
+ */
+bool LexiconTrie::isWord(int node) const{
+    return (nodes[node].letters & kWordFlag) != 0;
+}
+
+/* Function Synopsis:
+ * Returns true if the given word is in the trie. Upper and lower case letters are treated the same.
+ */
+bool LexiconTrie::contains(string word) const{
+    int node = 0;
+    for(char ch : word){
+        ch = tolower((unsigned char)ch);
+        if(ch < 'a' || ch > 'z'){
+            return false;
+        }
+        node = childFor(node, ch - 'a');
+        if(node < 0){
+            return false;
+        }
+    }
+    return isWord(node);
+}
+
+/* Function Synopsis:
+ * Writes the trie to the named file as kTrieFileMagic, the number of nodes, and then the node array exactly
+ * as it is laid out in memory, so that load can read it back with a single read. The file uses this
+ * machine's byte order. An error is reported if the file cannot be written.
+ */
+void LexiconTrie::save(string filename) const{
+    ofstream out(filename, ios::binary);
+    uint32_t count = nodes.size();
+    out.write(kTrieFileMagic, sizeof(kTrieFileMagic));
+    out.write((const char*)&count, sizeof(count));
+    out.write((const char*)nodes.data(), count * sizeof(TrieNode));
+    if(!out){
+        error("LexiconTrie::save: cannot write " + filename);
+    }
+}
+
+/* Function Synopsis:
+ * Reads a trie written by save from the named file. An error is reported if the file cannot be read or
+ * does not hold a valid trie.
+ */
+LexiconTrie LexiconTrie::load(string filename){
+    ifstream in(filename, ios::binary);
+    char magic[sizeof(kTrieFileMagic)];
+    uint32_t count = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*)&count, sizeof(count));
+    if(!in || !equal(magic, magic + sizeof(magic), kTrieFileMagic) || count == 0){
+        error("LexiconTrie::load: " + filename + " is not a trie file");
+    }
+
+    LexiconTrie trie;
+    trie.nodes.resize(count);
+    in.read((char*)trie.nodes.data(), count * sizeof(TrieNode));
+    if(!in){
+        error("LexiconTrie::load: " + filename + " is too short");
+    }
+    for(const TrieNode& node : trie.nodes){//makes sure childFor can never index past the end of the array
+        if(node.firstChild + bitset<32>(node.letters & kLetterBits).count() > count){
+            error("LexiconTrie::load: " + filename + " is corrupted");
+        }
+    }
+    return trie;
+}
+
+/* Struct Synopsis:
+ * A BoardSearch holds everything the backtracking search needs while scoring one board. The board letters
+ * and the neighbors of each cell are stored by cell index (row * numCols + col), with the neighbors as a
+ * bitmask so that removing the cells already on the path is a single & operation.
+ */
+struct BoardSearch {
+    const LexiconTrie& trie;
+    vector<int> letters;//letter in each cell, 0 for 'a' up to 25 for 'z', or -1 if the cell is not a letter
+    vector<uint64_t> neighbors;
+    vector<int>& foundOnBoard;//foundOnBoard[node] == boardId once the word at node has been scored
+    int boardId;
+    int score;
+};
+
+/* Function Synopsis:
+ * This helper extends the current path into cell, where node is the trie node for the letters on the path
+ * so far and visited has a bit set for each cell already on it. If the new letters spell a word it is scored,
+ * then the search recursively tries every unused neighbor, as long as some word starts with the new letters.
+ */
+void searchFrom(BoardSearch& search, int cell, int node, int length, uint64_t visited){
+    int letter = search.letters[cell];
+    if(letter < 0){
+        return;
+    }
+    node = search.trie.childFor(node, letter);
+    if(node < 0){//base case: no word starts with these letters
+        return;
+    }
+
+    length++;
+    if(length >= kMinWordLength && search.trie.isWord(node) && search.foundOnBoard[node] != search.boardId){
+        search.foundOnBoard[node] = search.boardId;
+        search.score += length - 3;
+    }
+    if(!search.trie.hasChildren(node)){
+        return;
+    }
+
+    //recursive case: try each neighbor that is not already on the path
+    visited |= uint64_t(1) << cell;
+    for(uint64_t options = search.neighbors[cell] & ~visited; options != 0; options &= options - 1){
+        int next = 0;
+        while(((options >> next) & 1) == 0){
+            next++;
+        }
+        searchFrom(search, next, node, length, visited);
+    }
+}
+
+/* Function Synopsis:
+ * This helper scores one board. foundOnBoard must have one entry per trie node and boardId must be different
+ * from every id used before with the same foundOnBoard, which lets it be reused without being cleared.
+ */
+int scoreBoard(const Grid<char>& board, const LexiconTrie& trie, vector<int>& foundOnBoard, int boardId){
+    int numRows = board.numRows();
+    int numCols = board.numCols();
+    if(numRows * numCols > kMaxBoardCells){
+        error("scoreBoard: boards can have at most " + to_string(kMaxBoardCells) + " cells");
+    }
+
+    BoardSearch search = {trie, {}, {}, foundOnBoard, boardId, 0};
+    for(int row = 0; row < numRows; row++){
+        for(int col = 0; col < numCols; col++){
+            char ch = tolower((unsigned char)board.get(row, col));
+            search.letters.push_back(ch >= 'a' && ch <= 'z' ? ch - 'a' : -1);
+
+            uint64_t mask = 0;
+            for(int dr = -1; dr <= 1; dr++){
+                for(int dc = -1; dc <= 1; dc++){
+                    if((dr != 0 || dc != 0) && board.inBounds(row + dr, col + dc)){
+                        mask |= uint64_t(1) << ((row + dr) * numCols + col + dc);
+                    }
+                }
+            }
+            search.neighbors.push_back(mask);
+        }
+    }
+
+    for(int cell = 0; cell < numRows * numCols; cell++){
+        searchFrom(search, cell, 0, 0, 0);
+    }
+    return search.score;
+}
+
+/* Function Synopsis:
+ * This function returns the total score of all the words that can be formed on the board.
+ */
+int scoreBoard(const Grid<char>& board, const LexiconTrie& trie){
+    vector<int> foundOnBoard(trie.size(), -1);
+    return scoreBoard(board, trie, foundOnBoard, 0);
+}
+
+/* Function Synopsis:
+ * This function scores every board using numThreads threads and returns the scores in the same order as
+ * the boards. The threads share the trie, which is never changed, and each thread takes the next unscored
+ * board whenever it finishes one so that slow boards do not hold the other threads up. An error is reported
+ * if numThreads is less than 1 or any board has more than kMaxBoardCells cells. The board sizes are checked
+ * before any thread starts, since an error raised inside a thread would end the whole program.
+ */
+Vector<int> scoreBoards(const Vector<Grid<char>>& boards, const LexiconTrie& trie, int numThreads){
+    if(numThreads < 1){
+        error("scoreBoards: numThreads must be at least 1");
+    }
+    for(const Grid<char>& board : boards){
+        if(board.numRows() * board.numCols() > kMaxBoardCells){
+            error("scoreBoards: boards can have at most " + to_string(kMaxBoardCells) + " cells");
+        }
+    }
+
+    vector<int> scores(boards.size(), 0);
+    atomic<int> nextBoard(0);
+    runInParallel(numThreads, [&](int){
+        vector<int> foundOnBoard(trie.size(), -1);
+        for(int i = nextBoard++; i < boards.size(); i = nextBoard++){
+            scores[i] = scoreBoard(boards[i], trie, foundOnBoard, i);
+        }
+    });
+
+    Vector<int> result;
+    for(int score : scores){
+        result.add(score);
+    }
+    return result;
+}
+
+
+/* * * * * * Test Code Below This Point * * * * * */
+
+/*
+ * This utility function scores a board the straightforward way, by backtracking with a Set of visited
+ * locations and asking the Lexicon about each prefix. It is used to check scoreBoard against.
+ */
+void referenceSearch(const Grid<char>& board, const Lexicon& lex, int row, int col, string word,
+                     Set<GridLocation>& visited, Set<string>& found){
+    word += tolower((unsigned char)board.get(row, col));
+    if(!lex.containsPrefix(word)){
+        return;
+    }
+    if((int)word.size() >= kMinWordLength && lex.contains(word)){
+        found.add(word);
+    }
+    visited.add({row, col});
+    for(int dr = -1; dr <= 1; dr++){
+        for(int dc = -1; dc <= 1; dc++){
+            if(board.inBounds(row + dr, col + dc) && !visited.contains({row + dr, col + dc})){
+                referenceSearch(board, lex, row + dr, col + dc, word, visited, found);
+            }
+        }
+    }
+    visited.remove({row, col});
+}
+
+int referenceScoreBoard(const Grid<char>& board, const Lexicon& lex){
+    Set<GridLocation> visited;
+    Set<string> found;
+    for(int row = 0; row < board.numRows(); row++){
+        for(int col = 0; col < board.numCols(); col++){
+            referenceSearch(board, lex, row, col, "", visited, found);
+        }
+    }
+    int score = 0;
+    for(string word : found){
+        score += word.size() - 3;
+    }
+    return score;
+}
+
+/*
+ * This utility function returns a board of the given size filled with random upper case letters.
+ */
+Grid<char> randomBoard(int numRows, int numCols){
+    const string kLetters = "AAAEEEEIIIOOUBCDDFGHLLMNNNPRRRSSSTTTTWY";//roughly English letter frequencies
+    Grid<char> board(numRows, numCols);
+    for(int row = 0; row < numRows; row++){
+        for(int col = 0; col < numCols; col++){
+            board.set(row, col, kLetters[randomInteger(0, kLetters.size() - 1)]);
+        }
+    }
+    return board;
+}
+
+STUDENT_TEST("LexiconTrie contains exactly the words it was built from"){
+    Vector<string> words = {"cat", "cats", "Cattle", "dog", "do", "x-ray", "", "caf\xe9"};
+    LexiconTrie trie(words);
+
+    EXPECT(trie.contains("cat"));
+    EXPECT(trie.contains("CATS"));
+    EXPECT(trie.contains("cattle"));
+    EXPECT(trie.contains("do"));
+    EXPECT(trie.contains("dog"));
+    EXPECT(!trie.contains("ca"));
+    EXPECT(!trie.contains("catt"));
+    EXPECT(!trie.contains("dogs"));
+    EXPECT(!trie.contains("x-ray"));
+    EXPECT(!trie.contains(""));
+    EXPECT(!trie.contains("caf\xe9"));//non-ASCII bytes are not letters
+}
+
+STUDENT_TEST("LexiconTrie ignores repeated words"){
+    Vector<string> words = {"cat", "Cat", "cats", "CAT", "dog", "dog"};
+    LexiconTrie trie(words);
+    Vector<string> unique = {"cat", "cats", "dog"};
+    LexiconTrie expected(unique);
+
+    EXPECT_EQUAL(trie.size(), expected.size());
+    EXPECT(trie.contains("cat"));
+    EXPECT(trie.contains("cats"));
+    EXPECT(trie.contains("dog"));
+    EXPECT(!trie.contains("ca"));
+}
+
+STUDENT_TEST("LexiconTrie save and load"){
+    Vector<string> words = {"apple", "apply", "ape", "banana", "band"};
+    LexiconTrie trie(words);
+    trie.save("trie_test.bin");
+
+    LexiconTrie loaded = LexiconTrie::load("trie_test.bin");
+    EXPECT_EQUAL(loaded.size(), trie.size());
+    for(string word : words){
+        EXPECT(loaded.contains(word));
+    }
+    EXPECT(!loaded.contains("app"));
+
+    ofstream bad("trie_test.bin", ios::binary);
+    bad << "not a trie";
+    bad.close();
+    EXPECT_ERROR(LexiconTrie::load("trie_test.bin"));
+    remove("trie_test.bin");
+}
+
+STUDENT_TEST("scoreBoard simple input"){
+    Grid<char> board = {{'C', 'A', 'T', 'S'},
+                        {'X', 'X', 'X', 'E'},
+                        {'X', 'X', 'X', 'X'},
+                        {'X', 'X', 'X', 'X'}};
+    Vector<string> words = {"cat", "cats", "cast", "caste", "case", "tsetse"};
+    LexiconTrie trie(words);
+
+    EXPECT_EQUAL(scoreBoard(board, trie), 1);//"cats" is the only word that fits, "cat" is too short
+
+    board.set(1, 1, 'S');//"cast" and "caste" now fit too
+    EXPECT_EQUAL(scoreBoard(board, trie), 1 + 1 + 2);
+}
+
+STUDENT_TEST("scoreBoard counts each word once and never reuses a cell"){
+    Grid<char> board = {{'N', 'O', 'O', 'N'},
+                        {'O', 'O', 'O', 'O'}};
+    Vector<string> words = {"noon", "nooo", "oooooo", "ooooooo"};
+    LexiconTrie trie(words);
+
+    EXPECT_EQUAL(scoreBoard(board, trie), 1 + 1 + 3);//only six O cells, so "ooooooo" is impossible
+}
+
+STUDENT_TEST("scoreBoard matches the Lexicon based reference"){
+    Lexicon lex("EnglishWords.txt");
+    LexiconTrie trie(lex);
+
+    for(int trial = 0; trial < 20; trial++){
+        Grid<char> board = randomBoard(randomInteger(1, 5), randomInteger(1, 5));
+        EXPECT_EQUAL(scoreBoard(board, trie), referenceScoreBoard(board, lex));
+    }
+}
+
+STUDENT_TEST("scoreBoards gives the same scores with any number of threads"){
+    Lexicon lex("EnglishWords.txt");
+    LexiconTrie trie(lex);
+    Vector<Grid<char>> boards;
+    Vector<int> expected;
+    for(int i = 0; i < 100; i++){
+        boards.add(randomBoard(4, 4));
+        expected.add(scoreBoard(boards[i], trie));
+    }
+
+    for(int numThreads = 1; numThreads <= 8; numThreads++){
+        EXPECT_EQUAL(scoreBoards(boards, trie, numThreads), expected);
+    }
+    EXPECT_ERROR(scoreBoards(boards, trie, 0));
+
+    boards.add(randomBoard(9, 9));//too many cells for the visited bitmask
+    EXPECT_ERROR(scoreBoards(boards, trie, 2));
+}
+
+STUDENT_TEST("Time LexiconTrie build, save and load"){
+    Lexicon lex("EnglishWords.txt");
+
+    LexiconTrie* trie = nullptr;
+    TIME_OPERATION(lex.size(), trie = new LexiconTrie(lex));
+    TIME_OPERATION(trie->size(), trie->save("trie_timing.bin"));
+    TIME_OPERATION(trie->size(), LexiconTrie::load("trie_timing.bin"));
+
+    delete trie;
+    remove("trie_timing.bin");
+}
+
+STUDENT_TEST("Time scoreBoards on 4x4 boards in boards per second"){
+    Lexicon lex("EnglishWords.txt");
+    LexiconTrie trie(lex);
+    int numBoards = 20000;
+    Vector<Grid<char>> boards;
+    for(int i = 0; i < numBoards; i++){
+        boards.add(randomBoard(4, 4));
+    }
+
+    for(int numThreads = 1; numThreads <= 8; numThreads *= 2){
+        auto start = chrono::steady_clock::now();
+        scoreBoards(boards, trie, numThreads);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        cout << numThreads << " thread(s): " << (long long)(numBoards / elapsed.count()) << " boards/second" << endl;
+    }
+}
+
+STUDENT_TEST("Time scoreBoard vs reference on 5x5 boards"){
+    Lexicon lex("EnglishWords.txt");
+    LexiconTrie trie(lex);
+    Grid<char> board = randomBoard(5, 5);
+
+    TIME_OPERATION(25, scoreBoard(board, trie));
+    TIME_OPERATION(25, referenceScoreBoard(board, lex));
+}
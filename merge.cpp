@@ -0,0 +1,446 @@
+/* File Synopsis:
+ * This file contains functions that merge many sorted linked lists into one sorted linked list. The
+ * multiMerge function uses a tournament (loser) tree so that merging N nodes from k lists takes O(N log k)
+ * comparisons instead of the O(N * k) steps needed when the lists are merged one pair at a time. Nodes are
+ * spliced from the input lists into the output, so no new nodes are allocated. The merge is stable: when
+ * two lists contain the same value, the node from the list with the lower index comes first.
+ *
+ * The parallelMultiMerge function splits the range of values into one slice per thread, cuts every input
+ * list at the slice boundaries, and merges each slice on its own thread before linking the slices together.
+ */
+
+#include <algorithm>
+#include <vector>
+#include "listnode.h"
+#include "parallel.h"
+#include "vector.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* Every kSampleStride-th node of each input list is sampled to choose the slice boundaries for
+ * parallelMultiMerge. Smaller strides give more evenly sized slices at the cost of a larger sample.
+ */
+const int kSampleStride = 64;
+
+ListNode* loserTreeMerge(const vector<ListNode*>& lists, ListNode*& tail);
+
+/* Struct Synopsis:
+ * A Player is the current front node of one input list as seen by the loser tree. The value is copied out
+ * of the node so that replaying a match only reads the tree array and never follows a node pointer.
+ */
+struct Player {
+    int value;
+    int source;//index of the input list this player came from
+    bool exhausted;//true once every node of the input list has been used
+};
+
+/* Function Synopsis:
+ * Returns true if player a should be output before player b. An exhausted list loses to every other list,
+ * and equal values are ordered by input list index so that the merge is stable.
+ */
+bool beats(const Player& a, const Player& b){
+    if(a.exhausted || b.exhausted){
+        return !a.exhausted;
+    }
+    if(a.value != b.value){
+        return a.value < b.value;
+    }
+    return a.source < b.source;
+}
+
+/* Function Synopsis:
+ * This function is passed two sorted linked lists and splices their nodes together into one sorted list,
+ * which is returned. When values are equal, nodes from a come before nodes from b.
+ */
+ListNode* binaryMerge(ListNode* a, ListNode* b){
+    ListNode dummy(0, nullptr);//placeholder front node, so the first spliced node needs no special case
+    ListNode* tail = &dummy;
+    while(a != nullptr && b != nullptr){
+        if(b->data < a->data){
+            tail->next = b;
+            b = b->next;
+        }
+        else{
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = (a != nullptr) ? a : b;//links whatever is left of the unfinished list
+    return dummy.next;
+}
+
+/* Function Synopsis:
+ * This function merges the sorted lists by repeatedly merging the next list into the result so far. It is
+ * kept as a simple reference to check multiMerge against and to compare running times: since the result
+ * keeps growing, merging N nodes from k lists takes O(N * k) time. The entries of lists are set to nullptr
+ * since their nodes now belong to the returned list.
+ */
+ListNode* pairwiseMultiMerge(Vector<ListNode*>& lists){
+    ListNode* result = nullptr;
+    for(int i = 0; i < lists.size(); i++){
+        result = binaryMerge(result, lists[i]);
+        lists[i] = nullptr;
+    }
+    return result;
+}
+
+/* Function Synopsis:
+ * This function merges the sorted lists into a single sorted list using a loser tree and returns it. The
+ * entries of lists are set to nullptr since their nodes now belong to the returned list.
+ */
+ListNode* multiMerge(Vector<ListNode*>& lists){
+    vector<ListNode*> fronts;
+    for(int i = 0; i < lists.size(); i++){
+        fronts.push_back(lists[i]);
+        lists[i] = nullptr;
+    }
+    ListNode* tail = nullptr;
+    return loserTreeMerge(fronts, tail);
+}
+
+/* Function Synopsis:
+ * This helper does the work of multiMerge. The tree is stored as an array the way a heap is: the k input
+ * lists are the leaves at indices k to 2k - 1, internal node n has children 2n and 2n + 1, each internal node
+ * remembers the player that lost the match played there, and index 0 holds the overall winner. After the
+ * winner's front node is spliced onto the output, only the matches on the path from its leaf to the root
+ * are replayed, which takes O(log k) comparisons. The last node of the merged list is stored in tail.
+ */
+ListNode* loserTreeMerge(const vector<ListNode*>& lists, ListNode*& tail){
+    int k = lists.size();
+    if(k == 0){
+        tail = nullptr;
+        return nullptr;
+    }
+
+    vector<ListNode*> fronts;//front node of each input list that has not been output yet
+    for(ListNode* list : lists){
+        fronts.push_back(list);
+    }
+
+    auto playerFor = [&](int source) -> Player {
+        if(fronts[source] == nullptr){
+            return {0, source, true};
+        }
+        return {fronts[source]->data, source, false};
+    };
+
+    //plays the initial tournament bottom-up, node k + i is the leaf for list i
+    vector<Player> tree(k);
+    vector<Player> winners(2 * k);
+    for(int i = 0; i < k; i++){
+        winners[k + i] = playerFor(i);
+    }
+    for(int node = k - 1; node >= 1; node--){
+        const Player& left = winners[2 * node];
+        const Player& right = winners[2 * node + 1];
+        if(beats(left, right)){
+            winners[node] = left;
+            tree[node] = right;
+        }
+        else{
+            winners[node] = right;
+            tree[node] = left;
+        }
+    }
+    tree[0] = winners[1];
+
+    ListNode dummy(0, nullptr);
+    tail = &dummy;
+    while(!tree[0].exhausted){
+        int source = tree[0].source;
+        tail->next = fronts[source];
+        tail = tail->next;
+        fronts[source] = fronts[source]->next;
+
+        Player cur = playerFor(source);
+        for(int node = (source + k) / 2; node >= 1; node /= 2){//replays the matches on the path to the root
+            if(beats(tree[node], cur)){
+                swap(tree[node], cur);
+            }
+        }
+        tree[0] = cur;
+    }
+    tail->next = nullptr;
+    if(tail == &dummy){
+        tail = nullptr;
+    }
+    return dummy.next;
+}
+
+/* Function Synopsis:
+ * This function produces the same list as multiMerge, using numThreads threads. It works in three steps:
+ *   1. Every kSampleStride-th value of each list is sampled, and the samples are sorted to choose
+ *      numThreads - 1 boundary values so that each slice of values holds about the same number of nodes.
+ *   2. Each list is cut at the boundaries, so slice r gets the nodes with values above boundary r - 1 and
+ *      at most boundary r. Equal values always land in the same slice, which keeps the merge stable.
+ *   3. Each slice is merged with its own loser tree on its own thread, and the slices are linked in order.
+ * Steps 1 and 2 split the input lists between the threads. The entries of lists are set to nullptr since
+ * their nodes now belong to the returned list.
+ */
+ListNode* parallelMultiMerge(Vector<ListNode*>& lists, int numThreads){
+    if(numThreads < 1){
+        error("parallelMultiMerge: numThreads must be at least 1");
+    }
+    int k = lists.size();
+    if(numThreads == 1 || k < 2){
+        return multiMerge(lists);
+    }
+
+    vector<ListNode*> fronts;
+    for(int i = 0; i < k; i++){
+        fronts.push_back(lists[i]);
+        lists[i] = nullptr;
+    }
+
+    //step 1: sample each list and choose the slice boundaries
+    vector<vector<int>> samples(numThreads);
+    runInParallel(numThreads, [&](int t){
+        for(int i = t; i < k; i += numThreads){
+            int index = 0;
+            for(ListNode* cur = fronts[i]; cur != nullptr; cur = cur->next){
+                if(index % kSampleStride == 0){
+                    samples[t].push_back(cur->data);
+                }
+                index++;
+            }
+        }
+    });
+    vector<int> allSamples;
+    for(const vector<int>& threadSamples : samples){
+        allSamples.insert(allSamples.end(), threadSamples.begin(), threadSamples.end());
+    }
+    sort(allSamples.begin(), allSamples.end());
+
+    vector<int> boundaries;
+    for(int r = 1; r < numThreads && !allSamples.empty(); r++){
+        int boundary = allSamples[(long long)r * allSamples.size() / numThreads];
+        if(boundaries.empty() || boundaries.back() < boundary){//skips repeats so that no slice is empty by design
+            boundaries.push_back(boundary);
+        }
+    }
+    int numSlices = boundaries.size() + 1;
+
+    //step 2: cut every list at the boundaries, slices[r][i] is the part of list i that belongs to slice r
+    vector<vector<ListNode*>> slices(numSlices, vector<ListNode*>(k, nullptr));
+    runInParallel(numThreads, [&](int t){
+        for(int i = t; i < k; i += numThreads){
+            ListNode* cur = fronts[i];
+            int r = 0;
+            while(cur != nullptr){
+                while(r < numSlices - 1 && cur->data > boundaries[r]){
+                    r++;
+                }
+                slices[r][i] = cur;
+                if(r == numSlices - 1){//the rest of the list belongs to the last slice
+                    break;
+                }
+                while(cur->next != nullptr && cur->next->data <= boundaries[r]){
+                    cur = cur->next;
+                }
+                ListNode* next = cur->next;
+                cur->next = nullptr;//cuts the list at the end of this slice
+                cur = next;
+            }
+        }
+    });
+
+    //step 3: merge each slice on its own thread, then link the slices together
+    vector<ListNode*> sliceFronts(numSlices, nullptr);
+    vector<ListNode*> sliceTails(numSlices, nullptr);
+    runInParallel(numSlices, [&](int r){
+        sliceFronts[r] = loserTreeMerge(slices[r], sliceTails[r]);
+    });
+
+    ListNode* result = nullptr;
+    ListNode* tail = nullptr;
+    for(int r = 0; r < numSlices; r++){
+        if(sliceFronts[r] == nullptr){
+            continue;
+        }
+        if(result == nullptr){
+            result = sliceFronts[r];
+        }
+        else{
+            tail->next = sliceFronts[r];
+        }
+        tail = sliceTails[r];
+    }
+    return result;
+}
+
+
+/* * * * * * Test Code Below This Point * * * * * */
+
+ListNode* createList(Vector<int> values);
+bool areEquivalent(ListNode* front, Vector<int> v);
+void deallocateList(ListNode* front);
+
+/*
+ * This utility function builds k sorted linked lists holding n random values in total. The
+ * same values are also added to all, so the expected merge result can be found by sorting it.
+ */
+Vector<ListNode*> createSortedLists(int k, int n, Vector<int>& all){
+    Vector<ListNode*> lists;
+    for(int i = 0; i < k; i++){
+        Vector<int> values;
+        for(int j = i; j < n; j += k){
+            values.add(randomInteger(-10000, 10000));
+        }
+        values.sort();
+        for(int value : values){
+            all.add(value);
+        }
+        lists.add(values.isEmpty() ? nullptr : createList(values));
+    }
+    all.sort();
+    return lists;
+}
+
+STUDENT_TEST("binaryMerge simple input"){
+    ListNode* merged = binaryMerge(createList({1, 4, 6}), createList({2, 3, 7, 9}));
+    EXPECT(areEquivalent(merged, {1, 2, 3, 4, 6, 7, 9}));
+    deallocateList(merged);
+
+    merged = binaryMerge(nullptr, createList({5}));
+    EXPECT(areEquivalent(merged, {5}));
+    deallocateList(merged);
+}
+
+STUDENT_TEST("multiMerge simple input"){
+    Vector<ListNode*> lists = {createList({1, 5, 9}), createList({2, 2, 8}), nullptr, createList({-3, 4})};
+
+    ListNode* merged = multiMerge(lists);
+    EXPECT(areEquivalent(merged, {-3, 1, 2, 2, 4, 5, 8, 9}));
+    for(ListNode* list : lists){
+        EXPECT(list == nullptr);
+    }
+    deallocateList(merged);
+}
+
+STUDENT_TEST("multiMerge edge cases"){
+    Vector<ListNode*> none;
+    EXPECT(multiMerge(none) == nullptr);
+
+    Vector<ListNode*> allEmpty = {nullptr, nullptr, nullptr};
+    EXPECT(multiMerge(allEmpty) == nullptr);
+
+    Vector<ListNode*> one = {createList({3, 4, 5})};
+    ListNode* merged = multiMerge(one);
+    EXPECT(areEquivalent(merged, {3, 4, 5}));
+    deallocateList(merged);
+}
+
+STUDENT_TEST("multiMerge is stable and does not allocate nodes"){
+    ListNode* first = createList({1, 2, 2});
+    ListNode* second = createList({2, 3});
+    ListNode* firstTwo = first->next;
+    ListNode* secondTwo = second;
+    Vector<ListNode*> lists = {first, second};
+
+    ListNode* merged = multiMerge(lists);
+    EXPECT(areEquivalent(merged, {1, 2, 2, 2, 3}));
+    EXPECT(merged == first);//the same nodes are reused
+    EXPECT(merged->next == firstTwo);//equal values from the first list come first
+    EXPECT(merged->next->next->next == secondTwo);
+    deallocateList(merged);
+}
+
+STUDENT_TEST("multiMerge matches pairwiseMultiMerge on random input"){
+    for(int k = 1; k <= 70; k += 3){
+        Vector<int> all;
+        Vector<ListNode*> lists = createSortedLists(k, randomInteger(0, 500), all);
+        Vector<ListNode*> copies;
+        for(ListNode* list : lists){
+            Vector<int> values;
+            for(ListNode* cur = list; cur != nullptr; cur = cur->next){
+                values.add(cur->data);
+            }
+            copies.add(values.isEmpty() ? nullptr : createList(values));
+        }
+
+        ListNode* merged = multiMerge(lists);
+        ListNode* expected = pairwiseMultiMerge(copies);
+        EXPECT(areEquivalent(merged, all));
+        EXPECT(areEquivalent(expected, all));
+
+        deallocateList(merged);
+        deallocateList(expected);
+    }
+}
+
+STUDENT_TEST("parallelMultiMerge matches multiMerge on random input"){
+    for(int numThreads = 1; numThreads <= 8; numThreads++){
+        Vector<int> all;
+        Vector<ListNode*> lists = createSortedLists(randomInteger(1, 40), randomInteger(0, 5000), all);
+
+        ListNode* merged = parallelMultiMerge(lists, numThreads);
+        EXPECT(areEquivalent(merged, all));
+        for(ListNode* list : lists){
+            EXPECT(list == nullptr);
+        }
+        deallocateList(merged);
+    }
+}
+
+STUDENT_TEST("parallelMultiMerge edge cases"){
+    ListNode* first = createList({7, 7});
+    ListNode* second = createList({7});
+    Vector<ListNode*> sameValue = {first, second, createList({7, 7, 7})};
+    ListNode* merged = parallelMultiMerge(sameValue, 4);//every slice boundary is the same value
+    EXPECT(areEquivalent(merged, {7, 7, 7, 7, 7, 7}));
+    EXPECT(merged == first);//equal values keep the order of the input lists
+    EXPECT(merged->next->next == second);
+    deallocateList(merged);
+
+    Vector<ListNode*> allEmpty = {nullptr, nullptr};
+    EXPECT(parallelMultiMerge(allEmpty, 4) == nullptr);
+
+    Vector<ListNode*> lists = {createList({1})};
+    EXPECT_ERROR(parallelMultiMerge(lists, 0));
+    deallocateList(lists[0]);
+}
+
+STUDENT_TEST("Time pairwiseMultiMerge vs multiMerge (N = 200000)"){//pairwise grows with k, multiMerge with log k
+    int n = 200000;
+
+    for(int k = 4; k <= 1024; k *= 4) {
+        Vector<int> all;
+        Vector<ListNode*> lists = createSortedLists(k, n, all);
+        ListNode* merged = nullptr;
+        TIME_OPERATION(k, merged = multiMerge(lists));
+        deallocateList(merged);
+
+        if(k <= 256){
+            Vector<int> pairwiseAll;
+            lists = createSortedLists(k, n, pairwiseAll);
+            TIME_OPERATION(k, merged = pairwiseMultiMerge(lists));
+            deallocateList(merged);
+        }
+    }
+}
+
+STUDENT_TEST("Time multiMerge with thousands of lists (N = 2000000)"){
+    int n = 2000000;
+
+    for(int k = 1000; k <= 8000; k *= 2) {
+        Vector<int> all;
+        Vector<ListNode*> lists = createSortedLists(k, n, all);
+        ListNode* merged = nullptr;
+        TIME_OPERATION(k, merged = multiMerge(lists));
+        deallocateList(merged);
+    }
+}
+
+STUDENT_TEST("Time parallelMultiMerge (N = 4000000, k = 1024)"){
+    int n = 4000000;
+    int k = 1024;
+
+    for(int numThreads = 1; numThreads <= 8; numThreads *= 2) {
+        Vector<int> all;
+        Vector<ListNode*> lists = createSortedLists(k, n, all);
+        ListNode* merged = nullptr;
+        TIME_OPERATION(numThreads, merged = parallelMultiMerge(lists, numThreads));
+        deallocateList(merged);
+    }
+}
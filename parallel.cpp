@@ -0,0 +1,22 @@
+/* File Synopsis:
+ * This file contains the threading helper declared in parallel.h.
+ */
+
+#include "parallel.h"
+#include <thread>
+#include <vector>
+using namespace std;
+
+/* Function Synopsis:
+ * This helper starts one thread per task index and then joins every thread, so it returns only once all
+ * of the tasks are done.
+ */
+void runInParallel(int numThreads, const function<void(int)>& task){
+    vector<thread> threads;
+    for(int t = 0; t < numThreads; t++){
+        threads.emplace_back(task, t);
+    }
+    for(thread& worker : threads){
+        worker.join();
+    }
+}
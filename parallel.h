@@ -0,0 +1,17 @@
+/* File Synopsis:
+ * This file declares a small threading helper for the parts of this project that split their work
+ * across several threads.
+ */
+
+#ifndef _parallel_h
+#define _parallel_h
+
+#include <functional>
+
+/* Function Synopsis:
+ * Runs task(0), task(1), ..., task(numThreads - 1) at the same time on separate threads and waits for all
+ * of them to finish.
+ */
+void runInParallel(int numThreads, const std::function<void(int)>& task);
+
+#endif
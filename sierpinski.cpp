@@ -0,0 +1,286 @@
+/* File Synopsis:
+ * This file contains functions that draw a Sierpinski triangle of a given order as an image that is
+ * 2^order pixels wide and tall. The triangle is drawn in the orientation where the pixel in column x and
+ * row y is filled exactly when x & y == 0, so each row can be filled directly instead of drawing the 3^order
+ * small triangles one at a time. The image is written as a binary PGM (grayscale) or PPM (color) file a band
+ * of rows at a time, with the bands filled in parallel. Each band holds about kBandBytes bytes (but always at
+ * least one row), and at most 2 * numThreads bands are in memory at once, so memory use stays bounded even for
+ * high orders.
+ *
+ * The drawSierpinskiRecursive function draws the same triangle the classic recursive way. It is much slower
+ * and is kept to check the fast renderer against.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "grid.h"
+#include "parallel.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+enum class ImageFormat { PGM, PPM };
+
+const int kMaxOrder = 16;//a 65536 by 65536 image, which is already 4 GB as a PGM file
+const int kBandBytes = 1 << 16;//rows are filled and written in bands of about this many bytes
+const int kBlockPixels = 64;//number of pixels copied at a time when filling a row
+const unsigned char kFilled = 0;//black
+const unsigned char kEmpty = 255;//white
+
+/* Function Synopsis:
+ * Returns the number of bytes used to store each pixel in the given format.
+ */
+int bytesPerPixel(ImageFormat format){
+    return format == ImageFormat::PPM ? 3 : 1;
+}
+
+/* Function Synopsis:
+ * This function fills in row y of a Sierpinski triangle that is size pixels wide, where size is a power of
+ * two. The row is written to the bytes starting at row, using bytesPerPixel identical bytes for each pixel.
+ *
+ * The row is split into blocks of kBlockPixels pixels. Since every block starts at a multiple of
+ * kBlockPixels, which is a power of two, a pixel x = start + i is filled exactly when start & y == 0 and
+ * i & y == 0. The second test is the same for every block, so the pattern it gives is worked out once and
+ * each block is then either a copy of that pattern or entirely empty. Those whole-block copies are done with
+ * memcpy and memset, which the compiler and standard library turn into wide vector loads and stores.
+ */
+void fillSierpinskiRow(unsigned char* row, int y, int size, int bytesPerPixel){
+    int blockPixels = min(size, kBlockPixels);
+    int blockBytes = blockPixels * bytesPerPixel;
+
+    unsigned char pattern[kBlockPixels * 3];
+    for(int i = 0; i < blockPixels; i++){
+        memset(pattern + i * bytesPerPixel, (i & y) == 0 ? kFilled : kEmpty, bytesPerPixel);
+    }
+
+    for(int start = 0; start < size; start += blockPixels){
+        unsigned char* block = row + start * bytesPerPixel;
+        if((start & y) == 0){
+            memcpy(block, pattern, blockBytes);
+        }
+        else{
+            memset(block, kEmpty, blockBytes);
+        }
+    }
+}
+
+/* Function Synopsis:
+ * This function writes a Sierpinski triangle of the given order to out as a binary PGM or PPM image. The rows
+ * are split into bands of about kBandBytes bytes, which are filled into a ring of 2 * numThreads buffers. The
+ * numThreads worker threads are started once and each takes the next band from a shared counter, waiting
+ * only if the buffer that band needs has not been written out yet. Meanwhile one more thread writes the
+ * bands to out in order as they become ready, so filling and writing overlap. At most 2 * numThreads bands
+ * are held in memory at a time. An error is reported if the order or number of threads is not valid.
+ */
+void writeSierpinski(ostream& out, int order, ImageFormat format, int numThreads){
+    if(order < 0 || order > kMaxOrder){
+        error("writeSierpinski: order must be between 0 and " + to_string(kMaxOrder));
+    }
+    if(numThreads < 1){
+        error("writeSierpinski: numThreads must be at least 1");
+    }
+
+    int size = 1 << order;
+    int pixelBytes = bytesPerPixel(format);
+    size_t rowBytes = (size_t)size * pixelBytes;
+    int bandRows = max<size_t>(1, kBandBytes / rowBytes);
+    int numBands = (size + bandRows - 1) / bandRows;
+    int numBuffers = min(numBands, 2 * numThreads);
+
+    out << (format == ImageFormat::PPM ? "P6" : "P5") << "\n" << size << " " << size << "\n255\n";
+
+    vector<vector<unsigned char>> buffers(numBuffers, vector<unsigned char>(rowBytes * min(size, bandRows)));
+    vector<int> bandInBuffer(numBuffers, -1);//band that has been filled into each buffer, -1 if none
+    int nextBand = 0;//next band to hand to a worker
+    int numWritten = 0;//bands 0 to numWritten - 1 have been written, so their buffers can be reused
+    mutex lock;
+    condition_variable changed;
+
+    runInParallel(numThreads + 1, [&](int t){
+        if(t == numThreads){//the writer: waits for each band in order and writes it out
+            for(int band = 0; band < numBands; band++){
+                int buffer = band % numBuffers;
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [&]{ return bandInBuffer[buffer] == band; });
+                guard.unlock();
+
+                int numRows = min(size, (band + 1) * bandRows) - band * bandRows;
+                out.write((const char*)buffers[buffer].data(), numRows * rowBytes);
+
+                guard.lock();
+                numWritten++;
+                changed.notify_all();
+            }
+            return;
+        }
+
+        while(true){//a worker: fills bands until there are none left
+            unique_lock<mutex> guard(lock);
+            if(nextBand >= numBands){
+                return;
+            }
+            int band = nextBand++;
+            changed.wait(guard, [&]{ return band < numWritten + numBuffers; });//the buffer's old band is written
+            guard.unlock();
+
+            int buffer = band % numBuffers;
+            int firstRow = band * bandRows;
+            for(int y = firstRow; y < min(size, firstRow + bandRows); y++){
+                fillSierpinskiRow(buffers[buffer].data() + (y - firstRow) * rowBytes, y, size, pixelBytes);
+            }
+
+            guard.lock();
+            bandInBuffer[buffer] = band;
+            changed.notify_all();
+        }
+    });
+}
+
+/* Function Synopsis:
+ * This function writes a Sierpinski triangle of the given order to the named file using writeSierpinski.
+ * An error is reported if the file cannot be written.
+ */
+void writeSierpinskiFile(string filename, int order, ImageFormat format, int numThreads){
+    ofstream out(filename, ios::binary);
+    if(!out){
+        error("writeSierpinskiFile: cannot open " + filename);
+    }
+    writeSierpinski(out, order, format, numThreads);
+    if(!out){
+        error("writeSierpinskiFile: cannot write " + filename);
+    }
+}
+
+/* Function Synopsis:
+ * This function draws a Sierpinski triangle of the given order into image, with its corner at column x and
+ * row y, by marking the filled pixels as true. An order 0 triangle is a single pixel. A triangle of any
+ * higher order is made of three triangles of one order less: one at the corner, one to its right and one
+ * below it, each half as wide. The image is passed by reference so that it can be drawn on.
+ */
+void drawSierpinskiRecursive(Grid<bool>& image, int x, int y, int order){
+    if(order == 0){//base case
+        image[y][x] = true;
+        return;
+    }
+
+    //else: recursive case
+    int half = 1 << (order - 1);
+    drawSierpinskiRecursive(image, x, y, order - 1);
+    drawSierpinskiRecursive(image, x + half, y, order - 1);
+    drawSierpinskiRecursive(image, x, y + half, order - 1);
+}
+
+
+/* * * * * * Test Code Below This Point * * * * * */
+
+/*
+ * This utility function checks that image holds a valid PGM or PPM file for a Sierpinski triangle of the
+ * given order, by comparing every pixel against drawSierpinskiRecursive.
+ */
+bool matchesRecursive(string image, int order, ImageFormat format){
+    int size = 1 << order;
+    Grid<bool> expected(size, size, false);
+    drawSierpinskiRecursive(expected, 0, 0, order);
+
+    ostringstream header;
+    header << (format == ImageFormat::PPM ? "P6" : "P5") << "\n" << size << " " << size << "\n255\n";
+    int pixelBytes = bytesPerPixel(format);
+    if(image.size() != header.str().size() + (size_t)size * size * pixelBytes || image.compare(0, header.str().size(), header.str()) != 0){
+        return false;
+    }
+
+    const unsigned char* pixels = (const unsigned char*)image.data() + header.str().size();
+    for(int y = 0; y < size; y++){
+        for(int x = 0; x < size; x++){
+            for(int b = 0; b < pixelBytes; b++){
+                if(pixels[((size_t)y * size + x) * pixelBytes + b] != (expected[y][x] ? kFilled : kEmpty)){
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * This utility function fills every row of a Sierpinski triangle of the given order into pixels, one byte
+ * per pixel, on a single thread. It is used to time fillSierpinskiRow on its own.
+ */
+void fillSierpinskiImage(vector<unsigned char>& pixels, int order){
+    int size = 1 << order;
+    for(int y = 0; y < size; y++){
+        fillSierpinskiRow(pixels.data() + (size_t)y * size, y, size, 1);
+    }
+}
+
+STUDENT_TEST("drawSierpinskiRecursive order 2"){
+    Grid<bool> image(4, 4, false);
+    drawSierpinskiRecursive(image, 0, 0, 2);
+
+    Grid<bool> expected = {{true,  true,  true,  true},
+                           {true,  false, true,  false},
+                           {true,  true,  false, false},
+                           {true,  false, false, false}};
+    EXPECT_EQUAL(image, expected);
+}
+
+STUDENT_TEST("fillSierpinskiRow matches x & y == 0"){
+    int size = 256;
+    vector<unsigned char> row(size);
+    for(int y = 0; y < size; y++){
+        fillSierpinskiRow(row.data(), y, size, 1);
+        for(int x = 0; x < size; x++){
+            EXPECT_EQUAL(row[x], (x & y) == 0 ? kFilled : kEmpty);
+        }
+    }
+}
+
+STUDENT_TEST("writeSierpinski matches drawSierpinskiRecursive"){
+    for(int order = 0; order <= 9; order++){
+        for(int numThreads = 1; numThreads <= 3; numThreads++){
+            ostringstream pgm;
+            writeSierpinski(pgm, order, ImageFormat::PGM, numThreads);
+            EXPECT(matchesRecursive(pgm.str(), order, ImageFormat::PGM));
+
+            ostringstream ppm;
+            writeSierpinski(ppm, order, ImageFormat::PPM, numThreads);
+            EXPECT(matchesRecursive(ppm.str(), order, ImageFormat::PPM));
+        }
+    }
+}
+
+STUDENT_TEST("writeSierpinski reports errors for bad arguments"){
+    ostringstream out;
+    EXPECT_ERROR(writeSierpinski(out, -1, ImageFormat::PGM, 1));
+    EXPECT_ERROR(writeSierpinski(out, kMaxOrder + 1, ImageFormat::PGM, 1));
+    EXPECT_ERROR(writeSierpinski(out, 3, ImageFormat::PGM, 0));
+}
+
+STUDENT_TEST("Time drawSierpinskiRecursive vs fillSierpinskiRow"){
+    for(int order = 8; order <= 12; order++){
+        int size = 1 << order;
+        Grid<bool> image(size, size, false);
+        TIME_OPERATION(size * size, drawSierpinskiRecursive(image, 0, 0, order));
+
+        vector<unsigned char> pixels((size_t)size * size);
+        TIME_OPERATION(size * size, fillSierpinskiImage(pixels, order));
+    }
+}
+
+STUDENT_TEST("Time writeSierpinski order 13 in pixels per second"){
+    int order = 13;
+    long long numPixels = (1LL << order) * (1LL << order);
+
+    for(int numThreads = 1; numThreads <= 8; numThreads *= 2){
+        ostringstream out;
+        auto start = chrono::steady_clock::now();
+        writeSierpinski(out, order, ImageFormat::PGM, numThreads);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        cout << numThreads << " thread(s): " << (long long)(numPixels / elapsed.count()) << " pixels/second" << endl;
+    }
+}
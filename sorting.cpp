@@ -1,7 +1,8 @@
 /* File Synopsis:
  * This file contains the quickSort function along with helper and testing functions. The quickSort function
  * recursively partitions a linked list into three separate lists and merges them together into a fully
- * sorted list.
+ * sorted list. It also contains LazySortedList, topK and nthElement, which reuse the partition function to
+ * find the smallest values of a list without sorting all of it.
  *
  * Outside help: I received advice from Shreya Pandey regarding the partition function. I was previously
  * sorting new elements into the greaterThan and lessThan lists by traversing through those lists and adding
@@ -160,6 +161,234 @@ ListNode* concatenate(ListNode*& lessThan, ListNode*& pivot, ListNode*& greaterT
 }
 
 
+/* Function Synopsis:
+ * This helper returns the number of nodes in the given linked list. It runs in O(N) time.
+ */
+int listLength(ListNode* front){
+    int count = 0;
+    for(ListNode* cur = front; cur != nullptr; cur = cur->next){
+        count++;
+    }
+    return count;
+}
+
+/* Function Synopsis:
+ * This helper adds the run of nodes starting at run to the end of the list described by front and tail.
+ * The front and tail pointers are passed in by reference and updated. Only the new run is walked, so
+ * repeatedly appending runs costs O(total length of the runs) rather than O(N) per append.
+ */
+void appendRun(ListNode*& front, ListNode*& tail, ListNode* run){
+    if(run == nullptr){
+        return;
+    }
+    if(front == nullptr){
+        front = run;
+    }
+    else{
+        tail->next = run;
+    }
+    tail = run;
+    while(tail->next != nullptr){//walks to the last node of the run so the next append can link to it
+        tail = tail->next;
+    }
+}
+
+/* Class Synopsis:
+ * LazySortedList hands out the nodes of a linked list in ascending order, one at a time, doing only as much
+ * partitioning as is needed to find the next smallest value. It keeps a stack of sublists that have not
+ * been handed out yet; every value in a sublist is smaller than every value in the sublists below it on the
+ * stack. When the top sublist is not known to be sorted it is split with the partition function, and the
+ * greaterThan, pivot and lessThan lists are pushed back in that order. The pivot list only ever holds copies
+ * of one value so it is marked as sorted and its nodes can be handed out directly.
+ *
+ * Taking every node costs the same O(N log N) expected time as quickSort, while taking only the first k
+ * nodes costs O(N + k log k) expected time. Like quickSort, the first node of each sublist is used as the
+ * pivot, so already sorted input is the worst case.
+ */
+class LazySortedList {
+public:
+    LazySortedList(ListNode* front);
+    ~LazySortedList();
+
+    bool hasNext() const;
+    ListNode* next();
+    ListNode* release();
+
+private:
+    struct Sublist {
+        ListNode* front;
+        bool sorted;//true when every node in the sublist has the same value
+    };
+    Vector<Sublist> pending;//top of the stack is the last element and holds the smallest values
+
+    LazySortedList(const LazySortedList&) = delete;
+    LazySortedList& operator=(const LazySortedList&) = delete;
+};
+
+/* Function Synopsis:
+ * The constructor takes ownership of every node in the given linked list. The list is not touched until
+ * the first call to next.
+ */
+LazySortedList::LazySortedList(ListNode* front){
+    if(front != nullptr){
+        pending.add({front, false});
+    }
+}
+
+/* Function Synopsis:
+ * The destructor deallocates every node that was not handed out by next or given back by release.
+ */
+LazySortedList::~LazySortedList(){
+    ListNode* cur = release();
+    while(cur != nullptr){
+        ListNode* next = cur->next;
+        delete cur;
+        cur = next;
+    }
+}
+
+/* Function Synopsis:
+ * Returns true if there are still nodes left to be handed out.
+ */
+bool LazySortedList::hasNext() const{
+    return !pending.isEmpty();
+}
+
+/* Function Synopsis:
+ * Detaches and returns the node holding the smallest remaining value, or nullptr if every node has already
+ * been handed out. The caller becomes responsible for deallocating the returned node.
+ */
+ListNode* LazySortedList::next(){
+    while(!pending.isEmpty()){
+        int top = pending.size() - 1;
+        ListNode* front = pending[top].front;
+
+        if(pending[top].sorted || front->next == nullptr){//front is the smallest remaining node
+            if(front->next == nullptr){
+                pending.remove(top);
+            }
+            else{
+                pending[top].front = front->next;
+            }
+            front->next = nullptr;
+            return front;
+        }
+
+        //else: split the top sublist, pushing the largest values first so the smallest end up on top
+        pending.remove(top);
+        ListNode* lessThan = nullptr;
+        ListNode* greaterThan = nullptr;
+        partition(lessThan, front, greaterThan);
+
+        if(greaterThan != nullptr){
+            pending.add({greaterThan, false});
+        }
+        pending.add({front, true});
+        if(lessThan != nullptr){
+            pending.add({lessThan, false});
+        }
+    }
+    return nullptr;
+}
+
+/* Function Synopsis:
+ * Gives back every node that has not been handed out yet as a single linked list and leaves the
+ * LazySortedList empty. The nodes are grouped so that every value comes before all larger values in other
+ * groups, but the nodes within a group are in no particular order.
+ */
+ListNode* LazySortedList::release(){
+    ListNode* result = nullptr;
+    ListNode* tail = nullptr;
+    for(int i = pending.size() - 1; i >= 0; i--){
+        appendRun(result, tail, pending[i].front);
+    }
+    pending.clear();
+    return result;
+}
+
+/* Function Synopsis:
+ * This function detaches the k smallest values from the list passed in by reference and returns them as a
+ * new linked list in ascending order. The nodes that are left over stay in front, in no particular order.
+ * If the list has fewer than k nodes, every node is returned and front becomes empty. The expected running
+ * time is O(N + k log k), which is much faster than quickSort when k is much smaller than N.
+ */
+ListNode* topK(ListNode*& front, int k){
+    if(k < 0){
+        error("topK: k cannot be negative");
+    }
+
+    LazySortedList sorted(front);
+    front = nullptr;
+
+    ListNode* result = nullptr;
+    ListNode* tail = nullptr;
+    for(int i = 0; i < k && sorted.hasNext(); i++){
+        appendRun(result, tail, sorted.next());
+    }
+
+    front = sorted.release();
+    return result;
+}
+
+/* Function Synopsis:
+ * This function returns the value that would be at index n (counting from 0) if the list were sorted. Like
+ * std::nth_element, it also rearranges the list passed in by reference so that the node at index n holds
+ * that value, every node before it is less than or equal to it, and every node after it is greater than or
+ * equal to it. Only the sublist containing index n is partitioned at each step, so the expected running time
+ * is O(N). An error is reported if n is not a valid index.
+ */
+int nthElement(ListNode*& front, int n){
+    if(n < 0 || n >= listLength(front)){
+        error("nthElement: index is out of range");
+    }
+
+    ListNode* before = nullptr;//nodes known to belong before the current sublist
+    ListNode* beforeTail = nullptr;
+    ListNode* after = nullptr;//nodes known to belong after the current sublist
+    ListNode* cur = front;//sublist that contains index n, n is relative to the start of this sublist
+
+    while(cur->next != nullptr){
+        ListNode* lessThan = nullptr;
+        ListNode* greaterThan = nullptr;
+        partition(lessThan, cur, greaterThan);
+
+        int numLess = listLength(lessThan);
+        int numPivot = listLength(cur);
+
+        if(n < numLess){//answer is in lessThan, everything else goes after it
+            ListNode* rest = nullptr;
+            ListNode* restTail = nullptr;
+            appendRun(rest, restTail, cur);
+            appendRun(rest, restTail, greaterThan);
+            restTail->next = after;
+            after = rest;
+            cur = lessThan;
+        }
+        else if(n < numLess + numPivot){//answer is the pivot value, put the sublist back together
+            cur = concatenate(lessThan, cur, greaterThan);
+            break;
+        }
+        else{//answer is in greaterThan, everything else goes before it
+            appendRun(before, beforeTail, lessThan);
+            appendRun(before, beforeTail, cur);
+            n -= numLess + numPivot;
+            cur = greaterThan;
+        }
+    }
+
+    ListNode* nth = cur;
+    for(int i = 0; i < n; i++){
+        nth = nth->next;
+    }
+    int result = nth->data;
+
+    appendRun(before, beforeTail, cur);
+    beforeTail->next = after;
+    front = before;
+    return result;
+}
+
+
 
 /* * * * * * Test Code Below This Point * * * * * */
 
@@ -194,16 +423,15 @@ void deallocateList(ListNode* front) {
         ListNode* cur = front->next;
         if(cur!=nullptr){
             while(cur->next != nullptr){//get to the last element, delete all previous along the way
-                delete[] prev;
+                delete prev;
                 prev = cur;
                 cur = cur->next;
-                //delete[] prev;
             }
-            delete[] prev;
-            delete[] cur;//delete last element
+            delete prev;
+            delete cur;//delete last element
         }
         else{//only 1 elem in list
-            delete[] prev;
+            delete prev;
         }
     }
 }
@@ -635,3 +863,197 @@ STUDENT_TEST("Testing areEquivalent"){
     deallocateList(valsList);
 
 }
+
+STUDENT_TEST("LazySortedList hands out every node in ascending order"){
+    Vector<int> values = {77, 3, -5, 61, 434, 60, 77, 76, 21, 33, -890, 46, 3, 3};
+    LazySortedList sorted(createList(values));
+    values.sort();
+
+    for(int i = 0; i < values.size(); i++){
+        EXPECT(sorted.hasNext());
+        ListNode* node = sorted.next();
+        EXPECT_EQUAL(node->data, values[i]);
+        EXPECT(node->next == nullptr);
+        delete node;
+    }
+    EXPECT(!sorted.hasNext());
+    EXPECT(sorted.next() == nullptr);
+}
+
+STUDENT_TEST("LazySortedList of an empty list"){
+    LazySortedList sorted(nullptr);
+    EXPECT(!sorted.hasNext());
+    EXPECT(sorted.next() == nullptr);
+    EXPECT(sorted.release() == nullptr);
+}
+
+STUDENT_TEST("LazySortedList release gives back the nodes that were not handed out"){
+    Vector<int> values = {9, 4, 7, 1, 8, 2, 6};
+    LazySortedList sorted(createList(values));
+
+    ListNode* first = sorted.next();
+    ListNode* second = sorted.next();
+    EXPECT_EQUAL(first->data, 1);
+    EXPECT_EQUAL(second->data, 2);
+
+    ListNode* rest = sorted.release();
+    EXPECT(!sorted.hasNext());
+    quickSort(rest);
+    EXPECT(areEquivalent(rest, {4, 6, 7, 8, 9}));
+
+    delete first;
+    delete second;
+    deallocateList(rest);
+}
+
+STUDENT_TEST("topK simple input"){
+    ListNode* list = createList({6, 3, 6, 6, 7, 2, 1, 6, 777, 2, 2, 4, 145, -13});
+
+    ListNode* smallest = topK(list, 4);
+    EXPECT(areEquivalent(smallest, {-13, 1, 2, 2}));
+
+    quickSort(list);
+    EXPECT(areEquivalent(list, {2, 3, 4, 6, 6, 6, 6, 7, 145, 777}));
+
+    deallocateList(smallest);
+    deallocateList(list);
+}
+
+STUDENT_TEST("topK edge cases"){
+    ListNode* list = createList({5, 1, 3});
+
+    ListNode* none = topK(list, 0);
+    EXPECT(none == nullptr);
+    EXPECT_EQUAL(listLength(list), 3);
+
+    ListNode* all = topK(list, 10);//asking for more nodes than the list has returns the whole list sorted
+    EXPECT(areEquivalent(all, {1, 3, 5}));
+    EXPECT(list == nullptr);
+
+    EXPECT_ERROR(topK(all, -1));
+    deallocateList(all);
+}
+
+STUDENT_TEST("topK matches sorting on random input"){
+    for(int trial = 0; trial < 20; trial++){
+        Vector<int> values;
+        int n = randomInteger(1, 200);
+        for(int i = 0; i < n; i++){
+            values.add(randomInteger(-50, 50));
+        }
+        int k = randomInteger(0, n);
+        ListNode* list = createList(values);
+
+        ListNode* smallest = topK(list, k);
+        values.sort();
+        EXPECT(areEquivalent(smallest, values.subList(0, k)));
+        EXPECT_EQUAL(listLength(list), n - k);
+
+        deallocateList(smallest);
+        deallocateList(list);
+    }
+}
+
+STUDENT_TEST("nthElement simple input"){
+    Vector<int> values = {6, 3, 6, 6, 7, 2, 1, 6, 777, 2, 2, 4, 145, -13};
+    ListNode* list = createList(values);
+
+    EXPECT_EQUAL(nthElement(list, 0), -13);
+    EXPECT_EQUAL(nthElement(list, 5), 3);
+    EXPECT_EQUAL(nthElement(list, 7), 6);
+    EXPECT_EQUAL(nthElement(list, 13), 777);
+    EXPECT_EQUAL(listLength(list), values.size());
+
+    EXPECT_ERROR(nthElement(list, -1));
+    EXPECT_ERROR(nthElement(list, 14));
+
+    deallocateList(list);
+}
+
+STUDENT_TEST("nthElement places the value at index n with smaller values before it"){
+    for(int trial = 0; trial < 20; trial++){
+        Vector<int> values;
+        int n = randomInteger(1, 200);
+        for(int i = 0; i < n; i++){
+            values.add(randomInteger(-50, 50));
+        }
+        int index = randomInteger(0, n - 1);
+        ListNode* list = createList(values);
+
+        int result = nthElement(list, index);
+        values.sort();
+        EXPECT_EQUAL(result, values[index]);
+
+        int i = 0;
+        for(ListNode* cur = list; cur != nullptr; cur = cur->next){
+            if(i < index){
+                EXPECT(cur->data <= result);
+            }
+            else if(i == index){
+                EXPECT_EQUAL(cur->data, result);
+            }
+            else{
+                EXPECT(cur->data >= result);
+            }
+            i++;
+        }
+        EXPECT_EQUAL(i, n);
+
+        deallocateList(list);
+    }
+}
+
+STUDENT_TEST("Time topK (k = 10) vs quickSort"){//topK should grow linearly and stay well below quickSort
+    int startSize = 500000;
+    int k = 10;
+
+    for(int n = startSize; n < 10*startSize; n *= 2) {
+        ListNode* list = nullptr;
+        ListNode* other = nullptr;
+        for (int i = n-1; i >= 0; i--) {
+            int value = randomInteger(-10000, 10000);
+            list = new ListNode(value, list);
+            other = new ListNode(value, other);
+        }
+
+        ListNode* smallest = nullptr;
+        TIME_OPERATION(n, smallest = topK(list, k));
+        TIME_OPERATION(n, quickSort(other));
+
+        deallocateList(smallest);
+        deallocateList(list);
+        deallocateList(other);
+    }
+}
+
+STUDENT_TEST("Time topK for growing k (N = 1000000)"){
+    int n = 1000000;
+
+    for(int k = 1; k <= n; k *= 10) {
+        ListNode* list = nullptr;
+        for (int i = n-1; i >= 0; i--) {
+            list = new ListNode(randomInteger(-10000, 10000), list);
+        }
+
+        ListNode* smallest = nullptr;
+        TIME_OPERATION(k, smallest = topK(list, k));
+
+        deallocateList(smallest);
+        deallocateList(list);
+    }
+}
+
+STUDENT_TEST("Time nthElement (median)"){//to confirm that runtime is O(N)
+    int startSize = 500000;
+
+    for(int n = startSize; n < 10*startSize; n *= 2) {
+        ListNode* list = nullptr;
+        for (int i = n-1; i >= 0; i--) {
+            list = new ListNode(randomInteger(-10000, 10000), list);
+        }
+
+        TIME_OPERATION(n, nthElement(list, n / 2));
+
+        deallocateList(list);
+    }
+}